@@ -0,0 +1,43 @@
+#include <stdatomic.h>
+#include <stdio.h>
+#include <time.h>
+#include "budget.h"
+
+// A monotonic clock can't be stepped by NTP or an admin while a budget runs
+#ifdef TIME_MONOTONIC
+#define BUDGET_CLOCK TIME_MONOTONIC
+#else
+#define BUDGET_CLOCK TIME_UTC
+#endif
+
+Budget budget_start(const CalculatorBudget *limits) {
+    Budget budget = {.limits = limits};
+    if (limits && limits->timeout_ms) {
+        timespec_get(&budget.deadline, BUDGET_CLOCK);
+        budget.deadline.tv_sec += limits->timeout_ms / 1000;
+        budget.deadline.tv_nsec += (long)(limits->timeout_ms % 1000) * 1000000;
+        if (budget.deadline.tv_nsec >= 1000000000) {
+            budget.deadline.tv_nsec -= 1000000000;
+            ++budget.deadline.tv_sec;
+        }
+    }
+    return budget;
+}
+
+bool budget_exhausted(const Budget *budget) {
+    if (!budget || !budget->limits) return false;
+    if (budget->limits->cancel && atomic_load_explicit(budget->limits->cancel, memory_order_relaxed)) {
+        fprintf(stderr, "Error: Evaluation cancelled\n");
+        return true;
+    }
+    if (budget->limits->timeout_ms) {
+        struct timespec now;
+        timespec_get(&now, BUDGET_CLOCK);
+        if (now.tv_sec > budget->deadline.tv_sec
+            || (now.tv_sec == budget->deadline.tv_sec && now.tv_nsec >= budget->deadline.tv_nsec)) {
+            fprintf(stderr, "Error: Evaluation timed out\n");
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,16 @@
+#ifndef BUDGET_H
+#define BUDGET_H
+
+#include <time.h>
+#include "calc.h"
+
+// A CalculatorBudget with its clock started, shared by the lexer and the evaluator
+typedef struct {
+    const CalculatorBudget *limits; // nullptr means unlimited
+    struct timespec deadline;
+} Budget;
+
+Budget budget_start(const CalculatorBudget *limits);
+bool budget_exhausted(const Budget *budget); // cancelled or past the deadline, prints why
+
+#endif
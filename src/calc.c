@@ -3,12 +3,15 @@
 #include <mpfr.h>
 #include <stdint.h>
 #include <stdio.h>
+#include "budget.h"
 #include "calc.h"
 #include "defs.h"
 #include "file_ops.h"
 #include "structs.h"
 #include "stack.h"
 #include "lexer.h"
+#include "sum.h"
+#include "eval.h"
 
 bool get_val(mpfr_t **val, Token *t) {
     assert(!(t->is_var && t->is_digit));
@@ -25,197 +28,427 @@ bool get_val(mpfr_t **val, Token *t) {
         *val = &vars[t->var - 'A'].var;
         return true;
     }
+    if (t->is_bool) {
+        fprintf(stderr, "Error: Expected a number, got a boolean\n");
+        return false;
+    }
     fprintf(stderr, "get_val: Invalid token type\n");
     return false;
 }
 
-bool result_is_boolean; // i cant be bothered to find a better way
+typedef struct {
+    const Budget *budget;
+    size_t depth;
+} EvalData;
+
+EvalResult eval_check_budget(const EvalData *data) {
+    return budget_exhausted(data->budget) ? EVAL_ABORTED : EVAL_OK;
+}
+
+void token_clear(Token *t) {
+    if (t->is_digit) mpfr_clear(t->digits);
+    else if (t->is_sum) sum_destroy(t);
+    *t = (Token){0};
+}
+
+// Consumes 't', numbers are true when nonzero
+EvalResult eval_truth(Token *t, bool *truth) {
+    mpfr_t *val;
+    EvalResult status = EVAL_OK;
+    if (t->is_bool) *truth = t->boolean;
+    else if ((t->is_sum && !sum_collapse(t)) || !get_val(&val, t)) status = EVAL_ERROR;
+    else *truth = !mpfr_zero_p(*val);
+    token_clear(t);
+    return status;
+}
+
+// Returns the index of the token that ends an operand of an operator with 'precedence', without evaluating anything
+size_t skip_operand(const TokenArray *tokens, size_t i, int8_t precedence) {
+    size_t depth = 0, nested_conditionals = 0;
+    for (; i < tokens->len; ++i) {
+        Token t = tokens->arr[i];
+        if (!t.is_operator || t.operation == NEGATE) continue;
+        if (t.operation == LEFT_PARENTHESIS) {
+            ++depth;
+        } else if (t.operation == RIGHT_PARENTHESIS) {
+            if (!depth) break;
+            --depth;
+        } else if (depth) {
+            continue;
+        } else if (t.operation == CONDITIONAL && precedence <= t.precedence) {
+            ++nested_conditionals;
+        } else if (t.operation == CONDITIONAL_ELSE && nested_conditionals) {
+            --nested_conditionals;
+        } else if (t.precedence <= precedence) {
+            break;
+        }
+    }
+    return i;
+}
+
+// Takes ownership of 'result': it is either pushed or cleared
+EvalResult eval_push_result(Stack *output_stack, Token result) {
+    if (!stack_push(output_stack, result)) {
+        token_clear(&result);
+        return EVAL_ERROR;
+    }
+    return EVAL_OK;
+}
+
+bool apply_power(mpfr_t result, mpfr_t base, mpfr_t exponent) {
+    if (mpfr_zero_p(base) && mpfr_sgn(exponent) < 0) {
+        fprintf(stderr, "Error: Division by zero\n");
+        return false;
+    }
+    // Reject results that would be out of range before doing any work, log2|result| = exponent * log2|base|
+    if (mpfr_regular_p(base) && mpfr_number_p(exponent)) {
+        mpfr_t estimate;
+        mpfr_init2(estimate, 32);
+        mpfr_abs(estimate, base, MPFR_RNDN);
+        mpfr_log2(estimate, estimate, MPFR_RNDN);
+        mpfr_mul(estimate, estimate, exponent, MPFR_RNDN);
+        bool too_large = mpfr_cmp_si(estimate, MAX_POWER_BITS) > 0;
+        bool too_small = mpfr_cmp_si(estimate, -MAX_POWER_BITS) < 0;
+        mpfr_clear(estimate);
+        if (too_large || too_small) {
+            fprintf(stderr, "Error: Exponentiation result is too %s\n", too_large ? "large" : "small");
+            return false;
+        }
+    }
+    mpfr_clear_flags();
+    // Integer exponents go through exponentiation by squaring
+    if (mpfr_integer_p(exponent) && mpfr_fits_slong_p(exponent, MPFR_RNDN)) {
+        long n = mpfr_get_si(exponent, MPFR_RNDN);
+        if (n >= 0) mpfr_pow_ui(result, base, (unsigned long)n, MPFR_RNDN);
+        else mpfr_pow_si(result, base, n, MPFR_RNDN);
+    } else {
+        mpfr_pow(result, base, exponent, MPFR_RNDN);
+    }
+    if (mpfr_nan_p(result)) {
+        fprintf(stderr, "Error: Exponentiation result is not a real number\n");
+        return false;
+    }
+    if (mpfr_overflow_p() || mpfr_underflow_p()) {
+        fprintf(stderr, "Error: Exponentiation result is too %s\n", mpfr_overflow_p() ? "large" : "small");
+        return false;
+    }
+    return true;
+}
 
-void apply_operator(Stack *output_stack, Token operator) {
-    Token operand1, operand2, result = {.is_digit = true};
-    mpfr_init2(result.digits, MIN_BITS);
+EvalResult apply_operator(Stack *output_stack, Token operator, const EvalData *data) {
+    EvalResult status = eval_check_budget(data);
+    if (status != EVAL_OK) return status;
+    if (operator.operation == LEFT_PARENTHESIS || operator.operation == CONDITIONAL) {
+        fprintf(stderr, "Error: Unmatched '%c'\n", operator.operation == CONDITIONAL ? '?' : '(');
+        return EVAL_ERROR;
+    }
+    Token operand1 = {0}, operand2 = {0}, result = {.is_digit = true};
+    mpfr_t *val1, *val2;
     if (operator.operation == NEGATE) {
-        if (stack_pop(output_stack, &operand1)) {
-            if (operand1.is_digit) {
-                mpfr_neg(result.digits, operand1.digits, MPFR_RNDN);
-                mpfr_clear(operand1.digits);
-            } else if (operand1.is_var) {
-                if (vars[operand1.var - 'A'].is_initialized) {
-                    mpfr_neg(result.digits, vars[operand1.var - 'A'].var, MPFR_RNDN);
-                } else {
-                    fprintf(stderr, "apply_operator 1: Variable '%c' is not defined\n", operand1.var);
-                    mpfr_clear(result.digits);
-                    return;
-                }
-            }
+        if (!stack_pop(output_stack, &operand1)) return EVAL_ERROR;
+        if ((operand1.is_sum && !sum_collapse(&operand1)) || !get_val(&val1, &operand1)) {
+            token_clear(&operand1);
+            return EVAL_ERROR;
         }
-        stack_push(output_stack, result);
-        return;
+        mpfr_init2(result.digits, MIN_BITS);
+        mpfr_neg(result.digits, *val1, MPFR_RNDN);
+        token_clear(&operand1);
+        return eval_push_result(output_stack, result);
     }
-    if (!stack_pop(output_stack, &operand2) || !stack_pop(output_stack, &operand1)) {
-        mpfr_clear(result.digits);
-        return;
+    if (!stack_pop(output_stack, &operand2)) return EVAL_ERROR;
+    if (!stack_pop(output_stack, &operand1)) {
+        token_clear(&operand2);
+        return EVAL_ERROR;
+    }
+    status = EVAL_ERROR;
+    if (operator.operation == ADD || operator.operation == SUBTRACT) {
+        // Flatten the whole chain into one n-ary sum instead of rounding after every step. The smaller side
+        // is merged into the larger one, so right-nested chains like 1-(1-(1-...)) stay linear too
+        bool negate = operator.operation == SUBTRACT;
+        size_t len1 = operand1.is_sum ? operand1.sum->len : 1, len2 = operand2.is_sum ? operand2.sum->len : 1;
+        Token *appended = &operand2;
+        if (operand2.is_sum && len2 > len1) {
+            result = operand2;
+            operand2 = (Token){0};
+            if (negate) result.sum->negated = !result.sum->negated;
+            appended = &operand1;
+            negate = false;
+        } else if (operand1.is_sum) {
+            result = operand1;
+            operand1 = (Token){0};
+        } else if (!sum_create(&result)) {
+            fprintf(stderr, "apply_operator: Malloc failed\n");
+            goto cleanup;
+        } else if (!sum_append(result.sum, &operand1, false)) {
+            sum_destroy(&result);
+            goto cleanup;
+        }
+        if (!sum_append(result.sum, appended, negate)) {
+            sum_destroy(&result);
+            goto cleanup;
+        }
+        status = eval_push_result(output_stack, result);
+        goto cleanup;
+    }
+    if ((operand1.is_sum && !sum_collapse(&operand1)) || (operand2.is_sum && !sum_collapse(&operand2))) goto cleanup;
+    if (operator.operation == AND || operator.operation == OR) {
+        bool truth1, truth2;
+        if (eval_truth(&operand1, &truth1) != EVAL_OK || eval_truth(&operand2, &truth2) != EVAL_OK) goto cleanup;
+        result = (Token){.is_bool = true, .boolean = operator.operation == AND ? truth1 && truth2 : truth1 || truth2};
+        status = eval_push_result(output_stack, result);
+        goto cleanup;
+    }
+    if ((operator.operation == EQUALITY || operator.operation == NOT_EQUAL) && operand1.is_bool && operand2.is_bool) {
+        result = (Token){.is_bool = true, .boolean = (operand1.boolean == operand2.boolean) == (operator.operation == EQUALITY)};
+        status = eval_push_result(output_stack, result);
+        goto cleanup;
     }
     if (operator.operation == SET_VAR) {
+        if (!operand1.is_var || !get_val(&val2, &operand2)) goto cleanup;
         if (!vars[operand1.var - 'A'].is_initialized) {
             mpfr_init2(vars[operand1.var - 'A'].var, MIN_BITS);
             vars[operand1.var - 'A'].is_initialized = true;
         }
-        if (operand2.is_digit) {
-            mpfr_set(vars[operand1.var - 'A'].var, operand2.digits, MPFR_RNDN);
-            mpfr_set(result.digits, operand2.digits, MPFR_RNDN);
-            if (operand2.is_digit) {
-                mpfr_clear(operand2.digits);
-            }
-            stack_push(output_stack, result);
-            write_all_vars();
-            return;
-        } else if (operand2.is_var) {
-            if (!vars[operand2.var - 'A'].is_initialized) {
-                fprintf(stderr, "apply_operator 2: Variable '%c' is not defined\n", operand2.var);
-                mpfr_clear(result.digits);
-                return;
-            }
-            mpfr_set(vars[operand1.var - 'A'].var, vars[operand2.var - 'A'].var, MPFR_RNDN);
-            mpfr_set(result.digits, vars[operand2.var - 'A'].var, MPFR_RNDN);
-            if (!stack_push(output_stack, result)) mpfr_clear(result.digits);
-            return;
-        }
-    }
-    mpfr_t *val1, *val2;
-    bool init_val1 = false, init_val2 = false;
-    if (get_val(&val1, &operand1)) {
-        init_val1 = true;
-    }
-    if (get_val(&val2, &operand2)) {
-        init_val2 = true;
+        mpfr_set(vars[operand1.var - 'A'].var, *val2, MPFR_RNDN);
+        mpfr_init2(result.digits, MIN_BITS);
+        mpfr_set(result.digits, *val2, MPFR_RNDN);
+        write_all_vars();
+        status = eval_push_result(output_stack, result);
+        goto cleanup;
     }
-    if (!init_val1 || !init_val2) {
+    if (!get_val(&val1, &operand1) || !get_val(&val2, &operand2)) goto cleanup;
+    if (operator.operation >= EQUALITY && operator.operation <= GREATER_EQUAL) {
+        int cmp = mpfr_cmp(*val1, *val2);
+        result = (Token){.is_bool = true};
+        switch (operator.operation) {
+            case EQUALITY: result.boolean = cmp == 0; break;
+            case NOT_EQUAL: result.boolean = cmp != 0; break;
+            case LESS: result.boolean = cmp < 0; break;
+            case LESS_EQUAL: result.boolean = cmp <= 0; break;
+            case GREATER: result.boolean = cmp > 0; break;
+            default: result.boolean = cmp >= 0; break;
+        }
+        status = eval_push_result(output_stack, result);
         goto cleanup;
     }
+    // A temporary left operand is reused as the destination, so a chain like a*b*c*d allocates once
+    bool in_place = operand1.is_digit && (operator.operation == MULTIPLY || operator.operation == DIVIDE);
+    mpfr_ptr dest = in_place ? operand1.digits : result.digits;
+    if (!in_place) mpfr_init2(result.digits, MIN_BITS);
     bool success = true;
     switch (operator.operation) {
-        case ADD: mpfr_add(result.digits, *val1, *val2, MPFR_RNDN); break;
-        case SUBTRACT: mpfr_sub(result.digits, *val1, *val2, MPFR_RNDN); break;
-        case MULTIPLY: mpfr_mul(result.digits, *val1, *val2, MPFR_RNDN); break;
+        case MULTIPLY: mpfr_mul(dest, *val1, *val2, MPFR_RNDN); break;
         case DIVIDE:
             if (mpfr_zero_p(*val2)) {
                 fprintf(stderr, "Error: Division by zero\n");
                 success = false;
             } else {
-                mpfr_div(result.digits, *val1, *val2, MPFR_RNDN);
+                mpfr_div(dest, *val1, *val2, MPFR_RNDN);
             }
             break;
-        case EQUALITY:
-            if (mpfr_cmp(*val1, *val2) == 0)
-                mpfr_set_ui(result.digits, 1, MPFR_RNDN);
-            else
-                mpfr_set_zero(result.digits, 1);
-            result_is_boolean = true;
-            break;
+        case POWER: success = apply_power(dest, *val1, *val2); break;
         default: success = false; break;
     }
+    if (in_place && success) {
+        result = operand1;
+        operand1 = (Token){0};
+    }
     if (success) {
-        stack_push(output_stack, result);
-    } else {
+        status = eval_push_result(output_stack, result);
+    } else if (!in_place) {
         mpfr_clear(result.digits);
     }
 cleanup:
-    if (operand1.is_digit) mpfr_clear(operand1.digits);
-    if (operand2.is_digit) mpfr_clear(operand2.digits);
+    token_clear(&operand1);
+    token_clear(&operand2);
+    return status;
 }
 
 CalculatorResult calculate_infix(const char *expression) {
-    result_is_boolean = false; 
-    TokenArray tokens = tokenize(expression);
-    if (!tokens.arr) return (CalculatorResult){0};
-#ifdef DEBUG
-    print_token_arr(&tokens);
-#endif
-    Stack *operator_stack = create_stack(tokens.len);
-    Stack *output_stack = create_stack(tokens.len);
+    return calculate_infix_budget(expression, nullptr);
+}
+
+EvalResult evaluate_tokens(TokenArray *tokens, bool move_literals, const Budget *budget, Token *result) {
+    EvalData data = {.budget = budget};
+    const CalculatorBudget *limits = budget ? budget->limits : nullptr;
+    if (limits && limits->max_tokens && tokens->len > limits->max_tokens) {
+        fprintf(stderr, "Error: Expression has %zu tokens, the limit is %zu\n", tokens->len, limits->max_tokens);
+        return EVAL_ABORTED;
+    }
+    Stack *operator_stack = create_stack(tokens->len);
+    Stack *output_stack = create_stack(tokens->len);
     if (!operator_stack || !output_stack) {
-        free_token_array(&tokens);
         if (operator_stack) destroy_stack(operator_stack);
         if (output_stack) destroy_stack(output_stack);
-        return (CalculatorResult){0};
+        return EVAL_ERROR;
     }
     // Process tokens using Shunting Yard algorithm
-    for (size_t i = 0; i < tokens.len; i++) {
-        Token current = tokens.arr[i];
+    EvalResult status = EVAL_OK;
+    for (size_t i = 0; i < tokens->len && status == EVAL_OK; i++) {
+        if ((status = eval_check_budget(&data)) != EVAL_OK) break;
+        Token current = tokens->arr[i];
         if (current.is_operator && current.operation == LEFT_PARENTHESIS) {
+            if (limits && limits->max_depth && ++data.depth > limits->max_depth) {
+                fprintf(stderr, "Error: Parenthesis nesting exceeds the limit of %zu\n", limits->max_depth);
+                status = EVAL_ABORTED;
+                break;
+            }
             stack_push(operator_stack, current);
         } else if (current.is_operator && current.operation == RIGHT_PARENTHESIS) {
+            if (data.depth) --data.depth;
             Token top_op;
-            while (!stack_is_empty(operator_stack)) {
-                stack_pop(operator_stack, &top_op);
+            while (status == EVAL_OK && stack_pop(operator_stack, &top_op)) {
                 if (top_op.is_operator && top_op.operation == LEFT_PARENTHESIS) {
                     break;
                 }
-                apply_operator(output_stack, top_op);
+                status = apply_operator(output_stack, top_op, &data);
             }
+        } else if (current.is_operator && current.operation == CONDITIONAL_ELSE) {
+            // The taken branch ends here, finish it and skip the other one
+            Token top_op;
+            bool found_conditional = false;
+            while (status == EVAL_OK && stack_pop(operator_stack, &top_op)) {
+                if (top_op.is_operator && top_op.operation == CONDITIONAL) {
+                    found_conditional = true;
+                    break;
+                }
+                status = apply_operator(output_stack, top_op, &data);
+            }
+            if (status == EVAL_OK && !found_conditional) {
+                fprintf(stderr, "Error: ':' without a matching '?'\n");
+                status = EVAL_ERROR;
+            }
+            i = skip_operand(tokens, i + 1, current.precedence) - 1;
         } else if (current.is_var) {
             stack_push(output_stack, current);
+        } else if (current.is_bool) {
+            stack_push(output_stack, current);
         } else if (current.is_digit) {
-            Token new_token = {
-                .is_digit = true,
-            };
-            mpfr_init2(new_token.digits, MIN_BITS);
-            mpfr_set(new_token.digits, current.digits, MPFR_RNDN);
-            stack_push(output_stack, new_token);
+            if (move_literals) {
+                // Move the literal out of the token array instead of copying it, free_token_array() skips it
+                tokens->arr[i].is_digit = false;
+            } else {
+                mpfr_init2(current.digits, MIN_BITS);
+                mpfr_set(current.digits, tokens->arr[i].digits, MPFR_RNDN);
+            }
+            status = eval_push_result(output_stack, current);
         } else {
             Token top_op;
-            while (!stack_is_empty(operator_stack) && stack_peek(operator_stack, &top_op) && (top_op.is_operator)
+            // A prefix operator has no left operand yet, so it must not pop anything
+            while (status == EVAL_OK && current.operation != NEGATE && stack_peek(operator_stack, &top_op) && top_op.is_operator
                    && ((top_op.precedence > current.precedence)
                        || (top_op.precedence == current.precedence && !current.is_right_associative))) {
                 if (!stack_pop(operator_stack, &top_op)) {
                     fprintf(stderr, "Failed to pop operator\n");
                     break;
                 }
-                apply_operator(output_stack, top_op);
+                status = apply_operator(output_stack, top_op, &data);
+            }
+            if (status != EVAL_OK) break;
+            if (current.operation == CONDITIONAL || current.operation == AND || current.operation == OR) {
+                // The left operand is complete on top of the output stack, so the untaken side can be skipped unevaluated
+                Token left;
+                bool truth = false;
+                if (!stack_pop(output_stack, &left)) {
+                    fprintf(stderr, "Error: Missing operand\n");
+                    status = EVAL_ERROR;
+                    break;
+                }
+                if ((status = eval_truth(&left, &truth)) != EVAL_OK) break;
+                if (current.operation == CONDITIONAL) {
+                    if (truth) {
+                        stack_push(operator_stack, current);
+                        continue;
+                    }
+                    size_t else_branch = skip_operand(tokens, i + 1, current.precedence);
+                    if (else_branch == tokens->len || tokens->arr[else_branch].operation != CONDITIONAL_ELSE) {
+                        fprintf(stderr, "Error: '?' without a matching ':'\n");
+                        status = EVAL_ERROR;
+                        break;
+                    }
+                    i = else_branch;
+                    continue;
+                }
+                stack_push(output_stack, (Token){.is_bool = true, .boolean = truth});
+                if (truth == (current.operation == OR)) {
+                    i = skip_operand(tokens, i + 1, current.precedence) - 1;
+                    continue;
+                }
             }
             stack_push(operator_stack, current);
         }
     }
     // Process remaining operators
     Token op;
-    while (stack_pop(operator_stack, &op)) {
-        apply_operator(output_stack, op);
+    while (status == EVAL_OK && stack_pop(operator_stack, &op)) {
+        status = apply_operator(output_stack, op, &data);
     }
 
-    Token final_result;
-    CalculatorResult calc_result = {.type = CALC_MPFR_STRING};
-    if (stack_pop(output_stack, &final_result) && stack_is_empty(output_stack)) {
-        if (result_is_boolean) {
-            if (mpfr_cmp_ui(final_result.digits, 1) == 0) {
-                calc_result.type = CALC_BOOLEAN_STRING;
-                calc_result.str = "true";
-            } else {
-                calc_result.type = CALC_BOOLEAN_STRING;
-                calc_result.str = "false";
-            }
-            mpfr_clear(final_result.digits);
-        } else if (final_result.is_digit) {
-            mpfr_asprintf(&calc_result.str, "%Rg", final_result.digits);
-            mpfr_clear(final_result.digits);
-        } else if (final_result.is_var) {
-            if (vars[final_result.var - 'A'].is_initialized) {
-                mpfr_asprintf(&calc_result.str, "%Rg", vars[final_result.var - 'A'].var);
-            } else {
-                fprintf(stderr, "calculate_infix: Variable '%c' is not defined\n", final_result.var);
-                calc_result.type = CALC_ERROR;
-            }
-        }
-    } else {
-        // Cleanup
-        while (stack_pop(output_stack, &final_result)) {
-            if (final_result.is_digit) {
-                mpfr_clear(final_result.digits);
-            }
+
+    if (status == EVAL_OK && output_stack->top == 1 && stack_pop(output_stack, result)) {
+        if (result->is_sum && !sum_collapse(result)) {
+            sum_destroy(result);
+            status = EVAL_ERROR;
         }
+    } else if (status == EVAL_OK) {
+        status = EVAL_ERROR;
+    }
+    // Cleanup, the operator stack holds no MPFR values
+    Token leftover;
+    while (stack_pop(output_stack, &leftover)) {
+        token_clear(&leftover);
     }
     destroy_stack(operator_stack);
     destroy_stack(output_stack);
-    free_token_array(&tokens);
+    return status;
+}
+
+// Consumes 'final_result' when 'status' is EVAL_OK
+CalculatorResult calculator_result(EvalResult status, Token *final_result) {
+    if (status == EVAL_ABORTED) return (CalculatorResult){.type = CALC_ABORTED};
+    if (status != EVAL_OK) return (CalculatorResult){0};
+    CalculatorResult calc_result = {.type = CALC_MPFR_STRING};
+    if (final_result->is_bool) {
+        calc_result.type = CALC_BOOLEAN_STRING;
+        calc_result.boolean = final_result->boolean;
+        calc_result.str = final_result->boolean ? "true" : "false";
+    } else if (final_result->is_digit) {
+        mpfr_asprintf(&calc_result.str, "%Rg", final_result->digits);
+        mpfr_clear(final_result->digits);
+    } else if (final_result->is_var) {
+        if (vars[final_result->var - 'A'].is_initialized) {
+            mpfr_asprintf(&calc_result.str, "%Rg", vars[final_result->var - 'A'].var);
+        } else {
+            fprintf(stderr, "calculate_infix: Variable '%c' is not defined\n", final_result->var);
+            calc_result.type = CALC_ERROR;
+        }
+    }
     return calc_result;
 }
+
+CalculatorResult calculate_infix_budget(const char *expression, const CalculatorBudget *budget) {
+    // The clock starts before lexing, a long expression spends its time there
+    Budget clock = budget_start(budget);
+    TokenArray tokens;
+    switch (tokenize(expression, &clock, &tokens)) {
+        case LEXER_OK: break;
+        case LEXER_ABORTED: return (CalculatorResult){.type = CALC_ABORTED};
+        default: return (CalculatorResult){0};
+    }
+#ifdef DEBUG
+    print_token_arr(&tokens);
+#endif
+    Token final_result;
+    EvalResult status = evaluate_tokens(&tokens, true, &clock, &final_result);
+    free_token_array(&tokens);
+    return calculator_result(status, &final_result);
+}
+
+CalculatorResult calculate_program(const CalculatorProgram *program, const CalculatorBudget *budget) {
+    Budget clock = budget_start(budget);
+    // Program tokens are static data, so literals are copied rather than moved
+    TokenArray tokens = program->tokens;
+    Token final_result;
+    EvalResult status = evaluate_tokens(&tokens, false, &clock, &final_result);
+    return calculator_result(status, &final_result);
+}
@@ -3,20 +3,40 @@
 
 #include <gmp.h>
 #include <mpfr.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include "file_ops.h"
 
 typedef enum {
     CALC_ERROR = 0,
     CALC_BOOLEAN_STRING,
     CALC_MPFR_STRING,
+    CALC_ABORTED, // a CalculatorBudget limit was hit or the evaluation was cancelled
 } CalculatorResultType;
 
 typedef struct {
     CalculatorResultType type;
     char *str;
+    bool boolean; // the value when the type is BOOLEAN_STRING
 } CalculatorResult;
 
+// Limits for a single evaluation, a zero field means unlimited. The deadline and the cancel flag are checked
+// between tokens, so max_length is the only bound on the time spent parsing a single literal.
+typedef struct {
+    size_t max_tokens;
+    size_t max_depth; // parenthesis nesting
+    size_t max_length; // characters, checked before anything is allocated
+    uint32_t timeout_ms;
+    const atomic_bool *cancel; // may be set from another thread
+} CalculatorBudget;
+
 // CAUTION! If the result type is MPFR_STRING, 'str' must be freed with mpfr_free_str()!
 CalculatorResult calculate_infix(const char *expression);
+CalculatorResult calculate_infix_budget(const char *expression, const CalculatorBudget *budget);
+
+// Expressions compiled into the build from the CALC_PROGRAMS file
+typedef struct CalculatorProgram CalculatorProgram;
+const CalculatorProgram *calculator_program(const char *name); // nullptr if there is no such program
+CalculatorResult calculate_program(const CalculatorProgram *program, const CalculatorBudget *budget);
 
 #endif
@@ -6,5 +6,6 @@
 
 #define MIN_BITS 256
 #define LETTERS 26
+#define MAX_POWER_BITS (1L << 24) // largest magnitude of log2|result| that '^' may produce
 
 #endif
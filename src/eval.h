@@ -0,0 +1,15 @@
+#ifndef EVAL_H
+#define EVAL_H
+
+#include "budget.h"
+#include "structs.h"
+
+typedef enum {
+    EVAL_OK,
+    EVAL_ERROR,
+    EVAL_ABORTED,
+} EvalResult;
+
+EvalResult evaluate_tokens(TokenArray *tokens, bool move_literals, const Budget *budget, Token *result);
+
+#endif
@@ -4,7 +4,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include "budget.h"
 #include "defs.h"
+#include "lexer.h"
 #include "structs.h"
 
 void free_token_array(TokenArray *arr) {
@@ -27,6 +29,14 @@ void print_token_arr(TokenArray *token_arr) {
             printf("Variable: %c\n", token_arr->arr[i].var);
             continue;
         }
+        if (token_arr->arr[i].is_bool) {
+            printf("Boolean: %s\n", token_arr->arr[i].boolean ? "true" : "false");
+            continue;
+        }
+        if (token_arr->arr[i].is_sum) {
+            printf("Sum: %zu terms\n", token_arr->arr[i].sum->len);
+            continue;
+        }
         printf("Operation: ");
         if (token_arr->arr[i].operation == ADD)
             printf("ADD");
@@ -38,6 +48,8 @@ void print_token_arr(TokenArray *token_arr) {
             printf("DIVIDE");
         else if (token_arr->arr[i].operation == MULTIPLY)
             printf("MULTIPLY");
+        else if (token_arr->arr[i].operation == POWER)
+            printf("POWER");
         else if (token_arr->arr[i].operation == LEFT_PARENTHESIS)
             printf("LEFT_PAREN");
         else if (token_arr->arr[i].operation == RIGHT_PARENTHESIS)
@@ -46,6 +58,24 @@ void print_token_arr(TokenArray *token_arr) {
             printf("SET_VAR");
         else if (token_arr->arr[i].operation == EQUALITY)
             printf("EQUALITY");
+        else if (token_arr->arr[i].operation == NOT_EQUAL)
+            printf("NOT_EQUAL");
+        else if (token_arr->arr[i].operation == LESS)
+            printf("LESS");
+        else if (token_arr->arr[i].operation == LESS_EQUAL)
+            printf("LESS_EQUAL");
+        else if (token_arr->arr[i].operation == GREATER)
+            printf("GREATER");
+        else if (token_arr->arr[i].operation == GREATER_EQUAL)
+            printf("GREATER_EQUAL");
+        else if (token_arr->arr[i].operation == AND)
+            printf("AND");
+        else if (token_arr->arr[i].operation == OR)
+            printf("OR");
+        else if (token_arr->arr[i].operation == CONDITIONAL)
+            printf("CONDITIONAL");
+        else if (token_arr->arr[i].operation == CONDITIONAL_ELSE)
+            printf("CONDITIONAL_ELSE");
         printf(", precedence: %d\n", token_arr->arr[i].precedence);
     }
 }
@@ -61,27 +91,36 @@ typedef struct {
     TokenArray arr;
     const char *str;
     size_t current_len;
+    size_t depth; // parenthesis nesting
+    size_t *conditionals; // unmatched '?' per nesting level
     bool expect_operand : 1, is_var_assignment : 1;
 } LexerData;
 
-typedef enum {
-    LEXER_OK,
-    LEXER_SKIP,
-    LEXER_ERROR,
-} LexerResult;
+// Every operator has to be followed by an operand and every operand by an operator, so that a branch the
+// evaluator skips without looking at it is still well formed
+LexerResult lexer_expect(LexerData *data, size_t i, bool operand) {
+    if (data->expect_operand == operand) return LEXER_OK;
+    lexer_print_error(operand ? "Unexpected operand" : "Unexpected operator", data->str, i);
+    free_token_array(&data->arr);
+    return LEXER_ERROR;
+}
 
 LexerResult lexer_handle_variable(LexerData *data, size_t i) {
     if (data->str[i] >= 'A' && data->str[i] <= 'Z') {
+        if (lexer_expect(data, i, true) == LEXER_ERROR) return LEXER_ERROR;
         data->arr.arr[data->arr.len++] = (Token){.is_var = true, .var = data->str[i]};
         data->expect_operand = false;
         return LEXER_SKIP;
     } else if (data->arr.len > 0 && data->str[i] == '=') {
+        if (lexer_expect(data, i, false) == LEXER_ERROR) return LEXER_ERROR;
         if (data->arr.arr[0].is_var && data->arr.len == 1) {
-            data->arr.arr[data->arr.len++] = (Token){.is_operator = true, .operation = SET_VAR, .is_right_associative = true};
+            data->arr.arr[data->arr.len++] = (Token){.is_operator = true, .operation = SET_VAR, .precedence = 1, .is_right_associative = true};
             data->is_var_assignment = true;
+            data->expect_operand = true;
             return LEXER_SKIP;
         } else if (!data->is_var_assignment) {
-            data->arr.arr[data->arr.len++] = (Token){.is_operator = true, .operation = EQUALITY};
+            data->arr.arr[data->arr.len++] = (Token){.is_operator = true, .operation = EQUALITY, .precedence = 5};
+            data->expect_operand = true;
             return LEXER_SKIP;
         } else {
             lexer_print_error("You can't use assignment and equality in the same expression", data->str, i);
@@ -94,6 +133,7 @@ LexerResult lexer_handle_variable(LexerData *data, size_t i) {
 
 LexerResult lexer_handle_number(LexerData *data, size_t *i) {
     if (!isdigit(data->str[*i])) return LEXER_OK;
+    if (lexer_expect(data, *i, true) == LEXER_ERROR) return LEXER_ERROR;
     size_t start = *i;
     bool is_digit = true, is_float = false;
     while (*i < data->current_len && is_digit) {
@@ -125,7 +165,7 @@ LexerResult lexer_handle_number(LexerData *data, size_t *i) {
     }
     memcpy(num, &(data->str[start]), digits);
     num[digits] = '\0';
-    data->arr.arr[data->arr.len].is_digit = true;
+    data->arr.arr[data->arr.len] = (Token){.is_digit = true};
     mpfr_init2(data->arr.arr[data->arr.len].digits, MIN_BITS);
     mpfr_set_str(data->arr.arr[data->arr.len++].digits, num, 0, MPFR_RNDN);
     free(num);
@@ -146,55 +186,118 @@ LexerResult lexer_handle_parenthesis(LexerData *data, size_t i) {
                 return LEXER_ERROR;
             } else {
                 data->arr.arr = new_arr;
-                data->arr.arr[data->arr.len++] = (Token){.is_operator = true, .operation = MULTIPLY, .precedence = 2};
+                data->arr.arr[data->arr.len++] = (Token){.is_operator = true, .operation = MULTIPLY, .precedence = 8};
+                data->expect_operand = true;
             }
         }
+        if (lexer_expect(data, i, true) == LEXER_ERROR) return LEXER_ERROR;
         data->arr.arr[data->arr.len++] = (Token){.is_operator = true, .operation = LEFT_PARENTHESIS};
+        data->conditionals[++data->depth] = 0;
         data->expect_operand = true;
         return LEXER_SKIP;
     } else if (data->str[i] == ')') {
+        if (lexer_expect(data, i, false) == LEXER_ERROR) return LEXER_ERROR;
+        if (!data->depth || data->conditionals[data->depth]) {
+            lexer_print_error(data->depth ? "Expected ':'" : "Unmatched ')'", data->str, i);
+            free_token_array(&data->arr);
+            return LEXER_ERROR;
+        }
+        --data->depth;
         data->arr.arr[data->arr.len++] = (Token){.is_operator = true, .operation = RIGHT_PARENTHESIS};
         return LEXER_SKIP;
     }
     return LEXER_OK;
 }
 
-LexerResult lexer_handle_operator(LexerData *data, size_t i) {
+LexerResult lexer_handle_operator(LexerData *data, size_t *i) {
     if (data->expect_operand) {
-        if (data->str[i] == '+') return LEXER_SKIP;
-        else if (data->str[i] == '-') {
+        if (data->str[*i] == '+') return LEXER_SKIP;
+        else if (data->str[*i] == '-') {
             if (data->arr.len > 0
                 && data->arr.arr[data->arr.len - 1].is_operator
                 && data->arr.arr[data->arr.len - 1].operation == NEGATE) {
                 data->arr.len--; // Remove the previous NEGATE
-            } else data->arr.arr[data->arr.len++] = (Token){.is_operator = true, .operation = NEGATE, .precedence = 5};
+            } else data->arr.arr[data->arr.len++] = (Token){.is_operator = true, .operation = NEGATE, .precedence = 11};
             return LEXER_SKIP;
         } else {
-            lexer_print_error("Unexpected operator", data->str, i);
+            lexer_print_error("Unexpected operator", data->str, *i);
             free_token_array(&data->arr);
             return LEXER_ERROR;
         }
     } else {
         Token t = {.is_operator = true};
-        switch (data->str[i]) {
+        char next = *i + 1 < data->current_len ? data->str[*i + 1] : '\0';
+        switch (data->str[*i]) {
             case '+':
                 t.operation = ADD;
-                t.precedence = 1;
+                t.precedence = 7;
                 break;
             case '-':
                 t.operation = SUBTRACT;
-                t.precedence = 1;
+                t.precedence = 7;
                 break;
             case '*':
                 t.operation = MULTIPLY;
-                t.precedence = 2;
+                t.precedence = 8;
                 break;
             case '/':
                 t.operation = DIVIDE;
+                t.precedence = 8;
+                break;
+            case '^':
+                // Binds tighter than unary minus so that -2^2 is -(2^2)
+                t.operation = POWER;
+                t.precedence = 12;
+                t.is_right_associative = true;
+                break;
+            case '<':
+            case '>':
+                if (next == '=') {
+                    t.operation = data->str[*i] == '<' ? LESS_EQUAL : GREATER_EQUAL;
+                    ++(*i);
+                } else {
+                    t.operation = data->str[*i] == '<' ? LESS : GREATER;
+                }
+                t.precedence = 6;
+                break;
+            case '!':
+                if (next != '=') goto invalid;
+                t.operation = NOT_EQUAL;
+                t.precedence = 5;
+                ++(*i);
+                break;
+            case '&':
+                if (next != '&') goto invalid;
+                t.operation = AND;
+                t.precedence = 4;
+                ++(*i);
+                break;
+            case '|':
+                if (next != '|') goto invalid;
+                t.operation = OR;
+                t.precedence = 3;
+                ++(*i);
+                break;
+            case '?':
+                t.operation = CONDITIONAL;
                 t.precedence = 2;
+                t.is_right_associative = true;
+                ++data->conditionals[data->depth];
+                break;
+            case ':':
+                if (!data->conditionals[data->depth]) {
+                    lexer_print_error("':' without a matching '?'", data->str, *i);
+                    free_token_array(&data->arr);
+                    return LEXER_ERROR;
+                }
+                --data->conditionals[data->depth];
+                t.operation = CONDITIONAL_ELSE;
+                t.precedence = 2;
+                t.is_right_associative = true;
                 break;
             default:
-                lexer_print_error("Invalid syntax", data->str, i);
+            invalid:
+                lexer_print_error("Invalid syntax", data->str, *i);
                 free_token_array(&data->arr);
                 return LEXER_ERROR;
         }
@@ -204,36 +307,66 @@ LexerResult lexer_handle_operator(LexerData *data, size_t i) {
     }
 }
 
-TokenArray tokenize(const char *str) {
+// Runs before every token, literals can be long enough for the deadline to pass in a single one
+LexerResult lexer_check_budget(LexerData *data, const Budget *budget) {
+    if (budget_exhausted(budget)) return LEXER_ABORTED;
+    if (budget && budget->limits && budget->limits->max_tokens && data->arr.len > budget->limits->max_tokens) {
+        fprintf(stderr, "Error: Expression has more than %zu tokens\n", budget->limits->max_tokens);
+        return LEXER_ABORTED;
+    }
+    return LEXER_OK;
+}
+
+LexerResult tokenize(const char *str, const Budget *budget, TokenArray *tokens) {
+    *tokens = (TokenArray){0};
     LexerData data = {
         .str = str,
         .current_len = strlen(str),
         .expect_operand = true,
         .is_var_assignment = false,
     };
+    if (budget && budget->limits && budget->limits->max_length && data.current_len > budget->limits->max_length) {
+        fprintf(stderr, "Error: Expression has %zu characters, the limit is %zu\n", data.current_len,
+                budget->limits->max_length);
+        return LEXER_ABORTED;
+    }
     if (!(data.arr.arr = calloc(data.current_len, sizeof(Token)))) {
         fprintf(stderr, "tokenize: Calloc failed\n");
-        return (TokenArray){0};
+        return LEXER_ERROR;
     }
     const size_t starting_len = data.current_len; // current_len might grow
+    if (!(data.conditionals = calloc(starting_len + 1, sizeof(size_t)))) {
+        fprintf(stderr, "tokenize: Calloc failed\n");
+        free(data.arr.arr);
+        return LEXER_ERROR;
+    }
+
+    LexerResult result = LEXER_OK;
+    for (size_t i = 0; i < starting_len && result != LEXER_ERROR; ++i) {
+        if ((result = lexer_check_budget(&data, budget)) != LEXER_OK) break;
 
-    LexerResult result;
-    for (size_t i = 0; i < starting_len; ++i) {
         result = lexer_handle_variable(&data, i);
-        if (result == LEXER_SKIP) continue;
-        if (result == LEXER_ERROR) return (TokenArray){0};
+        if (result != LEXER_OK) continue;
 
         result = lexer_handle_number(&data, &i);
-        if (result == LEXER_SKIP) continue;
-        if (result == LEXER_ERROR) return (TokenArray){0};
+        if (result != LEXER_OK) continue;
 
         result = lexer_handle_parenthesis(&data, i);
-        if (result == LEXER_SKIP) continue;
-        if (result == LEXER_ERROR) return (TokenArray){0};
+        if (result != LEXER_OK) continue;
 
-        result = lexer_handle_operator(&data, i);
-        if (result == LEXER_SKIP) continue;
-        if (result == LEXER_ERROR) return (TokenArray){0};
+        result = lexer_handle_operator(&data, &i);
     }
-    return data.arr;
+    if (result != LEXER_ERROR && result != LEXER_ABORTED) result = lexer_check_budget(&data, budget);
+    if (result == LEXER_ABORTED) {
+        free_token_array(&data.arr);
+    } else if (result != LEXER_ERROR && (data.expect_operand || data.depth || data.conditionals[0])) {
+        lexer_print_error(data.expect_operand ? "Expected an operand" : data.depth ? "Expected ')'" : "Expected ':'",
+                          str, starting_len);
+        free_token_array(&data.arr);
+        result = LEXER_ERROR;
+    }
+    free(data.conditionals);
+    if (result == LEXER_ERROR || result == LEXER_ABORTED) return result;
+    *tokens = data.arr;
+    return LEXER_OK;
 }
@@ -1,10 +1,18 @@
 #ifndef LEXER_H
 #define LEXER_H
 
+#include "budget.h"
 #include "structs.h"
 
+typedef enum {
+    LEXER_OK,
+    LEXER_SKIP,
+    LEXER_ERROR,
+    LEXER_ABORTED, // a budget limit was hit
+} LexerResult;
+
 void free_token_array(TokenArray *arr);
 void print_token_arr(TokenArray *token_arr);
-TokenArray tokenize(const char *str);
+LexerResult tokenize(const char *str, const Budget *budget, TokenArray *tokens);
 
 #endif
@@ -44,7 +44,7 @@ int main(void) {
             continue;
         }
         if (!strcmp(expression, "h")) {
-            printf("You can use parenthesis '()'\nYou can use A-Z as variables\nEnter 'q' to quit\n");
+            printf("You can use parenthesis '()'\nYou can use '^' for exponentiation\nYou can compare with '=', '!=', '<', '<=', '>', '>='\nYou can use '&&', '||' and 'condition ? a : b'\nYou can use A-Z as variables\nEnter 'q' to quit\n");
             free(expression);
             continue;
         }
@@ -66,7 +66,7 @@ int main(void) {
         }
         CalculatorResult result = calculate_infix(expression);
         free(expression);
-        if (result.type != CALC_ERROR) {
+        if (result.type == CALC_BOOLEAN_STRING || result.type == CALC_MPFR_STRING) {
             printf("Result: %s\n", result.str);
             if (result.type == CALC_MPFR_STRING) mpfr_free_str(result.str);
         }
@@ -0,0 +1,10 @@
+#include <string.h>
+#include "calc.h"
+#include "structs.h"
+
+const CalculatorProgram *calculator_program(const char *name) {
+    for (size_t i = 0; i < calc_programs_len; ++i) {
+        if (!strcmp(calc_programs[i].name, name)) return &calc_programs[i];
+    }
+    return nullptr;
+}
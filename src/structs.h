@@ -12,20 +12,34 @@ typedef enum : uint8_t {
     NEGATE,
     MULTIPLY,
     DIVIDE,
+    POWER,
     LEFT_PARENTHESIS,
     RIGHT_PARENTHESIS,
     SET_VAR,
     EQUALITY,
+    NOT_EQUAL,
+    LESS,
+    LESS_EQUAL,
+    GREATER,
+    GREATER_EQUAL,
+    AND,
+    OR,
+    CONDITIONAL,
+    CONDITIONAL_ELSE,
 } OperationType;
 
+typedef struct SumTerms SumTerms;
+
 typedef struct {
-    bool is_digit : 1, is_operator : 1, is_var : 1, is_right_associative : 1;
+    bool is_digit : 1, is_operator : 1, is_var : 1, is_right_associative : 1, is_sum : 1, is_bool : 1;
     int8_t precedence;
 
     union {
         OperationType operation;
         mpfr_t digits;
         char var;
+        SumTerms *sum;
+        bool boolean;
     };
 } Token;
 
@@ -34,6 +48,14 @@ typedef struct {
     size_t len;
 } TokenArray;
 
+// Pending terms of an ADD/SUBTRACT chain, summed with a single rounding once the value is needed
+struct SumTerms {
+    mpfr_t *terms;
+    size_t len;
+    size_t capacity;
+    bool negated; // the value is minus the sum of the terms
+};
+
 typedef struct {
     Token *items;
     size_t top;
@@ -46,5 +68,13 @@ typedef struct {
 } UserVars;
 extern UserVars vars[LETTERS];
 
+// A named expression pre-tokenized by calcc, see tools/calcc.c
+struct CalculatorProgram {
+    const char *name;
+    TokenArray tokens;
+};
+extern const struct CalculatorProgram calc_programs[];
+extern const size_t calc_programs_len;
+
 #endif
 
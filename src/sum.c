@@ -0,0 +1,100 @@
+#include <gmp.h>
+#include <mpfr.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "defs.h"
+#include "structs.h"
+
+bool sum_create(Token *token) {
+    SumTerms *sum = malloc(sizeof(SumTerms));
+    if (!sum) return false;
+    *sum = (SumTerms){.terms = malloc(sizeof(mpfr_t) * 16), .capacity = 16};
+    if (!sum->terms) {
+        free(sum);
+        return false;
+    }
+    *token = (Token){.is_sum = true, .sum = sum};
+    return true;
+}
+
+void sum_destroy(Token *token) {
+    for (size_t i = 0; i < token->sum->len; ++i) {
+        mpfr_clear(token->sum->terms[i]);
+    }
+    free(token->sum->terms);
+    free(token->sum);
+    *token = (Token){0};
+}
+
+bool sum_reserve(SumTerms *sum, size_t extra) {
+    if (sum->len + extra <= sum->capacity) return true;
+    size_t capacity = sum->capacity;
+    while (capacity < sum->len + extra) capacity *= 2;
+    mpfr_t *terms = realloc(sum->terms, sizeof(mpfr_t) * capacity);
+    if (!terms) {
+        fprintf(stderr, "sum_reserve: Realloc failed\n");
+        return false;
+    }
+    sum->terms = terms;
+    sum->capacity = capacity;
+    return true;
+}
+
+// On success 'token' is consumed: temporaries are moved into 'sum', variables are copied
+bool sum_append(SumTerms *sum, Token *token, bool negate) {
+    // Terms are stored relative to the sign of 'sum'
+    negate ^= sum->negated;
+    if (token->is_sum) {
+        if (!sum_reserve(sum, token->sum->len)) return false;
+        negate ^= token->sum->negated;
+        for (size_t i = 0; i < token->sum->len; ++i) {
+            sum->terms[sum->len][0] = token->sum->terms[i][0];
+            if (negate) mpfr_neg(sum->terms[sum->len], sum->terms[sum->len], MPFR_RNDN);
+            ++sum->len;
+        }
+        token->sum->len = 0;
+        sum_destroy(token);
+        return true;
+    }
+    if (!sum_reserve(sum, 1)) return false;
+    if (token->is_digit) {
+        sum->terms[sum->len][0] = token->digits[0];
+    } else if (token->is_var) {
+        if (!vars[token->var - 'A'].is_initialized) {
+            fprintf(stderr, "sum_append: Variable '%c' is not defined\n", token->var);
+            return false;
+        }
+        mpfr_init2(sum->terms[sum->len], MIN_BITS);
+        mpfr_set(sum->terms[sum->len], vars[token->var - 'A'].var, MPFR_RNDN);
+    } else if (token->is_bool) {
+        fprintf(stderr, "Error: Expected a number, got a boolean\n");
+        return false;
+    } else {
+        fprintf(stderr, "sum_append: Invalid token type\n");
+        return false;
+    }
+    if (negate) mpfr_neg(sum->terms[sum->len], sum->terms[sum->len], MPFR_RNDN);
+    ++sum->len;
+    *token = (Token){0};
+    return true;
+}
+
+// Replaces a sum token with a digit token holding the correctly rounded total
+bool sum_collapse(Token *token) {
+    mpfr_ptr *ptrs = malloc(sizeof(mpfr_ptr) * token->sum->len);
+    if (!ptrs) {
+        fprintf(stderr, "sum_collapse: Malloc failed\n");
+        return false;
+    }
+    for (size_t i = 0; i < token->sum->len; ++i) {
+        ptrs[i] = token->sum->terms[i];
+    }
+    Token result = {.is_digit = true};
+    mpfr_init2(result.digits, MIN_BITS);
+    mpfr_sum(result.digits, ptrs, token->sum->len, MPFR_RNDN);
+    if (token->sum->negated && !mpfr_zero_p(result.digits)) mpfr_neg(result.digits, result.digits, MPFR_RNDN);
+    free(ptrs);
+    sum_destroy(token);
+    *token = result;
+    return true;
+}
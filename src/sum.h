@@ -0,0 +1,11 @@
+#ifndef SUM_H
+#define SUM_H
+
+#include "structs.h"
+
+bool sum_create(Token *token);
+void sum_destroy(Token *token);
+bool sum_append(SumTerms *sum, Token *token, bool negate);
+bool sum_collapse(Token *token);
+
+#endif
@@ -0,0 +1,287 @@
+// calcc: compiles a .calc file of named expressions into C source for the library build
+//
+// Usage: calcc OUTPUT.c [INPUT.calc]
+//
+// Each non-empty line of the input is 'name = expression', lines starting with '#' are comments.
+// Names are lowercase identifiers so that they can't be confused with the variables A-Z, the
+// expression uses the same syntax as calculate_infix(). Every expression is tokenized here, and
+// parenthesized groups without variables, or the whole expression if it has none, are folded into
+// a single constant. Groups that are terms of a sum stay unfolded, the runtime rounds a sum only once.
+// The output holds the resulting tokens and their MPFR limbs as static data.
+#include <ctype.h>
+#include <fcntl.h>
+#include <gmp.h>
+#include <mpfr.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "calc.h"
+#include "defs.h"
+#include "eval.h"
+#include "lexer.h"
+#include "structs.h"
+
+static const char *operation_names[] = {
+    [ADD] = "ADD",
+    [SUBTRACT] = "SUBTRACT",
+    [NEGATE] = "NEGATE",
+    [MULTIPLY] = "MULTIPLY",
+    [DIVIDE] = "DIVIDE",
+    [POWER] = "POWER",
+    [LEFT_PARENTHESIS] = "LEFT_PARENTHESIS",
+    [RIGHT_PARENTHESIS] = "RIGHT_PARENTHESIS",
+    [SET_VAR] = "SET_VAR",
+    [EQUALITY] = "EQUALITY",
+    [NOT_EQUAL] = "NOT_EQUAL",
+    [LESS] = "LESS",
+    [LESS_EQUAL] = "LESS_EQUAL",
+    [GREATER] = "GREATER",
+    [GREATER_EQUAL] = "GREATER_EQUAL",
+    [AND] = "AND",
+    [OR] = "OR",
+    [CONDITIONAL] = "CONDITIONAL",
+    [CONDITIONAL_ELSE] = "CONDITIONAL_ELSE",
+};
+
+bool has_vars(const Token *tokens, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        if (tokens[i].is_var) return true;
+    }
+    return false;
+}
+
+// Replaces tokens[start..start + len) with their value, returns false and leaves them alone if they don't evaluate.
+// A quiet fold discards the evaluator's diagnostics, its failure is not an error.
+bool fold_range(TokenArray *tokens, size_t start, size_t len, bool quiet) {
+    Token value;
+    TokenArray range = {.arr = tokens->arr + start, .len = len};
+    int saved_stderr = -1;
+    if (quiet) {
+        fflush(stderr);
+        int null = open("/dev/null", O_WRONLY);
+        if (null != -1 && (saved_stderr = dup(STDERR_FILENO)) != -1) dup2(null, STDERR_FILENO);
+        if (null != -1) close(null);
+    }
+    EvalResult status = evaluate_tokens(&range, false, nullptr, &value);
+    if (saved_stderr != -1) {
+        fflush(stderr);
+        dup2(saved_stderr, STDERR_FILENO);
+        close(saved_stderr);
+    }
+    if (status != EVAL_OK) return false;
+    for (size_t i = start; i < start + len; ++i) {
+        if (tokens->arr[i].is_digit) mpfr_clear(tokens->arr[i].digits);
+    }
+    tokens->arr[start] = value;
+    memmove(&tokens->arr[start + 1], &tokens->arr[start + len], (tokens->len - start - len) * sizeof(Token));
+    tokens->len -= len - 1;
+    return true;
+}
+
+bool is_operation(const Token *t, OperationType operation) {
+    return t && t->is_operator && t->operation == operation;
+}
+
+// ADD and SUBTRACT collect their operands into one sum that is rounded once, also through NEGATE and redundant
+// parentheses, so a group that is a term of a sum has to stay unfolded to give the same result as calculate_infix()
+bool is_sum_term(const TokenArray *tokens, size_t start, size_t end) {
+    const Token *left, *right;
+    do {
+        while (start && is_operation(&tokens->arr[start - 1], NEGATE)) --start;
+        left = start ? &tokens->arr[--start] : nullptr;
+        right = end + 1 < tokens->len ? &tokens->arr[++end] : nullptr;
+    } while (is_operation(left, LEFT_PARENTHESIS) && is_operation(right, RIGHT_PARENTHESIS));
+    // An operator that binds tighter than '+' takes the group first and collapses it
+    bool left_takes = left && left->is_operator && left->precedence > 7;
+    bool right_takes = right && right->is_operator && right->precedence > 7;
+    return ((is_operation(left, ADD) || is_operation(left, SUBTRACT)) && !right_takes)
+        || ((is_operation(right, ADD) || is_operation(right, SUBTRACT)) && !left_takes);
+}
+
+// Groups that fail are left for the runtime, they may sit in a branch that is never taken
+bool fold_constants(TokenArray *tokens) {
+    if (!has_vars(tokens->arr, tokens->len)) return fold_range(tokens, 0, tokens->len, false);
+    // Innermost groups first: every ')' closes the most recent '(' still open
+    size_t *open = malloc(sizeof(size_t) * tokens->len);
+    if (!open) {
+        fprintf(stderr, "fold_constants: Malloc failed\n");
+        return false;
+    }
+    size_t depth = 0;
+    for (size_t i = 0; i < tokens->len; ++i) {
+        if (!tokens->arr[i].is_operator) continue;
+        if (tokens->arr[i].operation == LEFT_PARENTHESIS) {
+            open[depth++] = i;
+        } else if (tokens->arr[i].operation == RIGHT_PARENTHESIS && depth) {
+            size_t start = open[--depth];
+            if (!has_vars(&tokens->arr[start], i - start + 1) && !is_sum_term(tokens, start, i)
+                && fold_range(tokens, start, i - start + 1, true)) {
+                i = start;
+            }
+        }
+    }
+    free(open);
+    return true;
+}
+
+bool is_valid_name(const char *name) {
+    if (!islower((unsigned char)name[0]) && name[0] != '_') return false;
+    for (const char *c = name; *c; ++c) {
+        if (!islower((unsigned char)*c) && !isdigit((unsigned char)*c) && *c != '_') return false;
+    }
+    return true;
+}
+
+void write_token(FILE *out, const Token *t, size_t program, size_t index) {
+    if (t->is_digit) {
+        fprintf(out, "    {.is_digit = true, .digits = {{%ld, %d, (mpfr_exp_t)%jdLL, calc_limbs_%zu_%zu}}},\n",
+                (long)t->digits->_mpfr_prec, t->digits->_mpfr_sign, (intmax_t)t->digits->_mpfr_exp, program, index);
+    } else if (t->is_var) {
+        fprintf(out, "    {.is_var = true, .var = '%c'},\n", t->var);
+    } else if (t->is_bool) {
+        fprintf(out, "    {.is_bool = true, .boolean = %s},\n", t->boolean ? "true" : "false");
+    } else {
+        fprintf(out, "    {.is_operator = true, .is_right_associative = %s, .precedence = %d, .operation = %s},\n",
+                t->is_right_associative ? "true" : "false", t->precedence, operation_names[t->operation]);
+    }
+}
+
+void write_program(FILE *out, const TokenArray *tokens, size_t program) {
+    for (size_t i = 0; i < tokens->len; ++i) {
+        if (!tokens->arr[i].is_digit) continue;
+        size_t limbs = (mpfr_get_prec(tokens->arr[i].digits) + GMP_NUMB_BITS - 1) / GMP_NUMB_BITS;
+        // Only regular numbers have a significand, the limbs of zero, NaN and Inf are never written
+        bool regular = mpfr_regular_p(tokens->arr[i].digits);
+        fprintf(out, "static mp_limb_t calc_limbs_%zu_%zu[] = {", program, i);
+        for (size_t j = 0; j < limbs; ++j) {
+            fprintf(out, "%s(mp_limb_t)0x%llxULL", j ? ", " : "",
+                    regular ? (unsigned long long)tokens->arr[i].digits->_mpfr_d[j] : 0ULL);
+        }
+        fprintf(out, "};\n");
+    }
+    fprintf(out, "static Token calc_tokens_%zu[] = {\n", program);
+    for (size_t i = 0; i < tokens->len; ++i) {
+        write_token(out, &tokens->arr[i], program, i);
+    }
+    fprintf(out, "};\n\n");
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "Usage: %s OUTPUT.c [INPUT.calc]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    FILE *in = nullptr;
+    if (argc == 3 && !(in = fopen(argv[2], "r"))) {
+        fprintf(stderr, "calcc: Failed to open '%s'\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+    FILE *out = fopen(argv[1], "w");
+    if (!out) {
+        fprintf(stderr, "calcc: Failed to open '%s' for writing\n", argv[1]);
+        if (in) fclose(in);
+        return EXIT_FAILURE;
+    }
+    fprintf(out, "// Generated by calcc from %s, do not edit\n", argc == 3 ? argv[2] : "nothing");
+    fprintf(out, "#include <gmp.h>\n#include <mpfr.h>\n#include \"structs.h\"\n\n");
+    fprintf(out, "#if GMP_NUMB_BITS != %d\n#error \"calcc was run with a different limb size\"\n#endif\n\n", GMP_NUMB_BITS);
+
+    bool success = true;
+    size_t programs = 0, line_number = 0, capacity = 256;
+    char **names = malloc(sizeof(char *) * capacity);
+    size_t *lengths = malloc(sizeof(size_t) * capacity);
+    char line[4096];
+    while (success && names && lengths && in && fgets(line, sizeof(line), in)) {
+        ++line_number;
+        if (!strchr(line, '\n') && !feof(in)) {
+            fprintf(stderr, "%s:%zu: Line is longer than %zu characters\n", argv[2], line_number, sizeof(line) - 2);
+            success = false;
+            break;
+        }
+        // Drop the whitespace, like the REPL does
+        size_t read = 0, write = 0;
+        while (line[read] != '\0') {
+            if (!isspace((unsigned char)line[read++])) line[write++] = line[read - 1];
+        }
+        line[write] = '\0';
+        if (!line[0] || line[0] == '#') continue;
+        char *expression = strchr(line, '=');
+        if (!expression) {
+            fprintf(stderr, "%s:%zu: Expected 'name = expression'\n", argv[2], line_number);
+            success = false;
+            break;
+        }
+        *expression++ = '\0';
+        if (!is_valid_name(line)) {
+            fprintf(stderr, "%s:%zu: Invalid name '%s'\n", argv[2], line_number, line);
+            success = false;
+            break;
+        }
+        for (size_t i = 0; i < programs; ++i) {
+            if (!strcmp(names[i], line)) {
+                fprintf(stderr, "%s:%zu: '%s' is already defined\n", argv[2], line_number, line);
+                success = false;
+            }
+        }
+        if (!success) break;
+        TokenArray tokens;
+        if (tokenize(expression, nullptr, &tokens) != LEXER_OK) {
+            fprintf(stderr, "%s:%zu: Failed to parse '%s'\n", argv[2], line_number, line);
+            success = false;
+            break;
+        }
+        if (!fold_constants(&tokens)) {
+            fprintf(stderr, "%s:%zu: Failed to evaluate '%s'\n", argv[2], line_number, line);
+            free_token_array(&tokens);
+            success = false;
+            break;
+        }
+        if (programs == capacity) {
+            capacity *= 2;
+            char **new_names = realloc(names, sizeof(char *) * capacity);
+            if (new_names) names = new_names;
+            size_t *new_lengths = realloc(lengths, sizeof(size_t) * capacity);
+            if (new_lengths) lengths = new_lengths;
+            if (!new_names || !new_lengths) {
+                fprintf(stderr, "calcc: Realloc failed\n");
+                free_token_array(&tokens);
+                success = false;
+                break;
+            }
+        }
+        if (!(names[programs] = strdup(line))) {
+            fprintf(stderr, "calcc: Strdup failed\n");
+            free_token_array(&tokens);
+            success = false;
+            break;
+        }
+        write_program(out, &tokens, programs);
+        lengths[programs++] = tokens.len;
+        free_token_array(&tokens);
+    }
+    if (!names || !lengths) {
+        fprintf(stderr, "calcc: Malloc failed\n");
+        success = false;
+    }
+
+    if (success) {
+        fprintf(out, "const struct CalculatorProgram calc_programs[] = {\n");
+        for (size_t i = 0; i < programs; ++i) {
+            fprintf(out, "    {.name = \"%s\", .tokens = {.arr = calc_tokens_%zu, .len = %zu}},\n", names[i], i, lengths[i]);
+        }
+        if (!programs) fprintf(out, "    {0},\n");
+        fprintf(out, "};\nconst size_t calc_programs_len = %zu;\n", programs);
+    }
+    for (size_t i = 0; names && i < programs; ++i) {
+        free(names[i]);
+    }
+    free(names);
+    free(lengths);
+    cleanup_vars();
+    if (in) fclose(in);
+    fclose(out);
+    if (!success) remove(argv[1]);
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}